@@ -5,12 +5,16 @@
 #include <string.h>
 #include <glib.h>
 
+// Fixed compositor output rate; every source is rate-adapted to this
+#define OUTPUT_FPS 30
+
 typedef struct {
     int id;
     char *video_file;
     GstElement *source;
     GstElement *decodebin;
     GstElement *queue_video;
+    GstElement *videorate;
     GstElement *videoconvert;
     GstElement *videoscale;
     GstElement *capsfilter;
@@ -23,6 +27,12 @@ typedef struct {
     int xpos;
     int ypos;
     gboolean active;
+    // Frame rate adaptation stats; last_tick and frames_repeated are written
+    // by the videorate pad probe, frames_repeated is guarded by stats_lock
+    gint64 last_tick;
+    guint64 frames_repeated;
+    guint64 frames_dropped;
+    GMutex stats_lock;
 } VideoSource;
 
 typedef struct {
@@ -92,16 +102,54 @@ static VideoSource* create_video_source_struct(int id, const char *video_file, i
     source->xpos = xpos;
     source->ypos = ypos;
     source->active = FALSE;
+    source->last_tick = -1;
+    source->frames_repeated = 0;
+    source->frames_dropped = 0;
+    g_mutex_init(&source->stats_lock);
     return source;
 }
 
 static void free_video_source(VideoSource *source) {
     if (source) {
+        g_mutex_clear(&source->stats_lock);
         g_free(source->video_file);
         g_free(source);
     }
 }
 
+// Counts output ticks covered by each kept frame beyond the first. The tick
+// grid starts at the source's segment PTS, not the mixer's output position,
+// so this estimates the repeats rather than counting them.
+static GstPadProbeReturn on_rate_pad_probe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+    VideoSource *source = (VideoSource*)user_data;
+    
+    // Restart tick tracking after a flush or new segment (seek, restart)
+    if (GST_PAD_PROBE_INFO_TYPE(info) & GST_PAD_PROBE_TYPE_EVENT_BOTH) {
+        GstEvent *event = GST_PAD_PROBE_INFO_EVENT(info);
+        if (GST_EVENT_TYPE(event) == GST_EVENT_FLUSH_STOP || GST_EVENT_TYPE(event) == GST_EVENT_SEGMENT) {
+            source->last_tick = -1;
+        }
+        return GST_PAD_PROBE_OK;
+    }
+    
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    GstClockTime pts = GST_BUFFER_PTS(buffer);
+    if (!GST_CLOCK_TIME_IS_VALID(pts)) {
+        return GST_PAD_PROBE_OK;
+    }
+    
+    // Index of the output tick this frame lands in; keeps fractional gaps
+    gint64 tick = (gint64)gst_util_uint64_scale(pts, OUTPUT_FPS, GST_SECOND);
+    if (source->last_tick >= 0 && tick - source->last_tick > 1) {
+        g_mutex_lock(&source->stats_lock);
+        source->frames_repeated += (guint64)(tick - source->last_tick - 1);
+        g_mutex_unlock(&source->stats_lock);
+    }
+    source->last_tick = tick;
+    
+    return GST_PAD_PROBE_OK;
+}
+
 static gboolean add_source_idle(gpointer user_data) {
     VideoSource *source = (VideoSource*)user_data;
     char element_name[64];
@@ -141,6 +189,16 @@ static gboolean add_source_idle(gpointer user_data) {
     // Set queue properties for smooth playback
     g_object_set(source->queue_video, "max-size-buffers", 100, "max-size-bytes", 0, "max-size-time", 0, NULL);
     
+    sprintf(element_name, "videorate_%d", source->id);
+    source->videorate = gst_element_factory_make("videorate", element_name);
+    if (!source->videorate) {
+        g_print("Failed to create videorate element for source %d\n", source->id);
+        return G_SOURCE_REMOVE;
+    }
+    // Drop surplus frames before conversion; never duplicate here, the mixer
+    // repeats the last frame for sources slower than OUTPUT_FPS
+    g_object_set(source->videorate, "drop-only", TRUE, "max-rate", OUTPUT_FPS, NULL);
+    
     sprintf(element_name, "videoconvert_%d", source->id);
     source->videoconvert = gst_element_factory_make("videoconvert", element_name);
     if (!source->videoconvert) {
@@ -204,18 +262,26 @@ static gboolean add_source_idle(gpointer user_data) {
     // Add elements to pipeline
     gst_bin_add_many(GST_BIN(app_data.pipeline), 
                      source->source, source->decodebin, 
-                     source->queue_video, source->videoconvert, source->videoscale, source->capsfilter, source->clocksync,
+                     source->queue_video, source->videorate, source->videoconvert, source->videoscale, source->capsfilter, source->clocksync,
                      source->queue_audio, source->audioconvert, source->audioresample, NULL);
     
     // Link elements
     gst_element_link(source->source, source->decodebin);
-    gst_element_link(source->queue_video, source->videoconvert);
+    gst_element_link(source->queue_video, source->videorate);
+    gst_element_link(source->videorate, source->videoconvert);
     gst_element_link(source->videoconvert, source->videoscale);
     gst_element_link(source->videoscale, source->capsfilter);
     gst_element_link(source->capsfilter, source->clocksync);
     gst_element_link(source->queue_audio, source->audioconvert);
     gst_element_link(source->audioconvert, source->audioresample);
     
+    // Track frames the mixer will have to repeat for this source
+    GstPad *rate_pad = gst_element_get_static_pad(source->videorate, "src");
+    gst_pad_add_probe(rate_pad,
+                      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM | GST_PAD_PROBE_TYPE_EVENT_FLUSH,
+                      on_rate_pad_probe, source, NULL);
+    gst_object_unref(rate_pad);
+    
     // Connect decodebin to queues - pass the source struct
     g_signal_connect(source->decodebin, "pad-added", G_CALLBACK(on_pad_added), source);
     
@@ -254,6 +320,7 @@ static gboolean add_source_idle(gpointer user_data) {
     gst_element_sync_state_with_parent(source->source);
     gst_element_sync_state_with_parent(source->decodebin);
     gst_element_sync_state_with_parent(source->queue_video);
+    gst_element_sync_state_with_parent(source->videorate);
     gst_element_sync_state_with_parent(source->videoconvert);
     gst_element_sync_state_with_parent(source->videoscale);
     gst_element_sync_state_with_parent(source->capsfilter);
@@ -310,16 +377,20 @@ static gboolean remove_source_idle(gpointer user_data) {
         source->audio_sink_pad = NULL;
     }
     
+    // Keep the drop count once videorate is gone
+    g_object_get(source->videorate, "drop", &source->frames_dropped, NULL);
+    
     // Remove elements from pipeline
     gst_bin_remove_many(GST_BIN(app_data.pipeline), 
                         source->source, source->decodebin, 
-                        source->queue_video, source->videoconvert, source->videoscale, source->capsfilter, source->clocksync,
+                        source->queue_video, source->videorate, source->videoconvert, source->videoscale, source->capsfilter, source->clocksync,
                         source->queue_audio, source->audioconvert, source->audioresample, NULL);
     
     // Free element references
     source->source = NULL;
     source->decodebin = NULL;
     source->queue_video = NULL;
+    source->videorate = NULL;
     source->videoconvert = NULL;
     source->videoscale = NULL;
     source->capsfilter = NULL;
@@ -413,9 +484,16 @@ void list_sources() {
     g_print("Active sources:\n");
     for (iter = app_data.sources; iter != NULL; iter = iter->next) {
         VideoSource *source = (VideoSource*)iter->data;
-        g_print("  Source %d: %s at (%d, %d) - %s\n", 
+        if (source->videorate) {
+            g_object_get(source->videorate, "drop", &source->frames_dropped, NULL);
+        }
+        g_mutex_lock(&source->stats_lock);
+        guint64 repeated = source->frames_repeated;
+        g_mutex_unlock(&source->stats_lock);
+        g_print("  Source %d: %s at (%d, %d) - %s (dropped: %" G_GUINT64_FORMAT ", repeated (est.): %" G_GUINT64_FORMAT ")\n", 
                source->id, source->video_file, source->xpos, source->ypos,
-               source->active ? "ACTIVE" : "INACTIVE");
+               source->active ? "ACTIVE" : "INACTIVE",
+               source->frames_dropped, repeated);
     }
 }
 
@@ -578,6 +656,7 @@ int main(int argc, char *argv[]) {
     GstCaps *output_caps = gst_caps_new_simple("video/x-raw",
                                               "width", G_TYPE_INT, 1280,
                                               "height", G_TYPE_INT, 720,
+                                              "framerate", GST_TYPE_FRACTION, OUTPUT_FPS, 1,
                                               NULL);
     g_object_set(mixer_caps, "caps", output_caps, NULL);
     gst_caps_unref(output_caps);